@@ -0,0 +1,43 @@
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include "contig_digest.hpp"
+
+// -------------------------------------------------------------------------
+// contig_digest: prints the order-independent digest of a reference
+// solution file, in the same format as `kmer_hash <kmer_file> verify`.
+// Several files may be given; their contigs are combined into one digest
+// (e.g. the test_*.dat files written by the test run type). With -c the
+// contigs are digested in canonical orientation, to check --canonical runs.
+// -------------------------------------------------------------------------
+int main(int argc, char **argv) {
+    bool canonical = false;
+    int c;
+    while((c = getopt(argc, argv, "c")) != -1){
+        if(c == 'c'){
+            canonical = true;
+        } else {
+            optind = argc;
+            break;
+        }
+    }
+    if(optind >= argc){
+        fprintf(stderr, "Usage: ./contig_digest [-c] solution_file [solution_file ...]\n");
+        return 1;
+    }
+
+    ContigDigest digest;
+    try {
+        for(int i = optind; i < argc; i++){
+            digest += digest_file(argv[i], canonical);
+        }
+    } catch(const std::runtime_error &e) {
+        fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+
+    printf("Digest %s (%llu contigs, %llu bases)\n", digest.hash_str().c_str(),
+           (unsigned long long)digest.n_contigs, (unsigned long long)digest.total_length);
+    return 0;
+}
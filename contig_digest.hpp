@@ -0,0 +1,202 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+// Order-independent digest of a set of contigs.
+// Each contig is hashed to 128 bits and the hashes are summed modulo 2^128,
+// so the digest is the same no matter how the contigs are split over ranks
+// or in which order they are produced. The contig count and total length
+// are kept alongside to make mismatches easier to diagnose.
+struct ContigDigest {
+    uint64_t n_contigs = 0;
+    uint64_t total_length = 0;
+    uint64_t hash_lo = 0;
+    uint64_t hash_hi = 0;
+
+    // Fold one contig into the digest.
+    void add(const std::string& contig) noexcept;
+
+    // Combine with another (partial) digest. Commutative and associative.
+    ContigDigest& operator+=(const ContigDigest& digest) noexcept;
+
+    // Return the 128-bit hash as 32 hex digits.
+    std::string hash_str() const;
+
+    bool operator==(const ContigDigest& digest) const noexcept;
+    bool operator!=(const ContigDigest& digest) const noexcept;
+};
+
+// Binary operation for upcxx::reduce_all / reduce_one.
+struct op_digest_add {
+    ContigDigest operator()(ContigDigest a, const ContigDigest& b) const noexcept {
+        a += b;
+        return a;
+    }
+};
+
+// Reverse complement of a contig string.
+std::string revcomp_contig(const std::string& contig) {
+    std::string rc(contig.rbegin(), contig.rend());
+    for (auto& base : rc) {
+        switch (base) {
+        case 'A': base = 'T'; break;
+        case 'C': base = 'G'; break;
+        case 'G': base = 'C'; break;
+        case 'T': base = 'A'; break;
+        }
+    }
+    return rc;
+}
+
+// The smaller of a contig and its reverse complement (strand-independent form).
+std::string canonical_contig(const std::string& contig) {
+    std::string rc = revcomp_contig(contig);
+    return (rc < contig) ? rc : contig;
+}
+
+// splitmix64 finalizer
+uint64_t digest_mix(uint64_t x) noexcept {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+// Hash a byte string 8 bytes at a time, seeded so that two calls with
+// different seeds give independent 64-bit halves of the contig hash.
+uint64_t digest_hash64(const char* data, size_t len, uint64_t seed) noexcept {
+    uint64_t h = digest_mix(seed ^ (len * 0x9e3779b97f4a7c15ULL));
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        uint64_t word;
+        memcpy(&word, data + i, 8);
+        h = digest_mix(h ^ word) + i;
+    }
+    uint64_t tail = 0;
+    memcpy(&tail, data + i, len - i);
+    return digest_mix(h ^ tail ^ seed);
+}
+
+void ContigDigest::add(const std::string& contig) noexcept {
+    uint64_t lo = digest_hash64(contig.data(), contig.size(), 0x243f6a8885a308d3ULL);
+    uint64_t hi = digest_hash64(contig.data(), contig.size(), 0x13198a2e03707344ULL);
+    hash_lo += lo;
+    hash_hi += hi + (hash_lo < lo);
+    n_contigs++;
+    total_length += contig.size();
+}
+
+ContigDigest& ContigDigest::operator+=(const ContigDigest& digest) noexcept {
+    hash_lo += digest.hash_lo;
+    hash_hi += digest.hash_hi + (hash_lo < digest.hash_lo);
+    n_contigs += digest.n_contigs;
+    total_length += digest.total_length;
+    return *this;
+}
+
+std::string ContigDigest::hash_str() const {
+    char buf[33];
+    snprintf(buf, sizeof(buf), "%016llx%016llx", (unsigned long long)hash_hi,
+             (unsigned long long)hash_lo);
+    return std::string(buf, 32);
+}
+
+bool ContigDigest::operator==(const ContigDigest& digest) const noexcept {
+    return n_contigs == digest.n_contigs && total_length == digest.total_length &&
+           hash_lo == digest.hash_lo && hash_hi == digest.hash_hi;
+}
+
+bool ContigDigest::operator!=(const ContigDigest& digest) const noexcept {
+    return !(*this == digest);
+}
+
+// Digest a solution file with one contig per line (e.g. test_solution.txt).
+// With canonical set, each contig is digested in its canonical orientation,
+// matching the output of kmer_hash --canonical.
+ContigDigest digest_file(const std::string& fname, bool canonical = false) {
+    std::ifstream fin(fname);
+    if (!fin.is_open()) {
+        throw std::runtime_error("digest_file: could not open " + fname);
+    }
+    ContigDigest digest;
+    std::string contig;
+    while (std::getline(fin, contig)) {
+        if (!contig.empty()) {
+            digest.add(canonical ? canonical_contig(contig) : contig);
+        }
+    }
+    return digest;
+}
+
+// Parse a stored digest: the 32 hex digits alone, or a line as printed by
+// contig_digest and kmer_hash verify, "Digest <hex> (N contigs, M bases)".
+// has_counts tells whether the contig count and total length were given.
+// Returns false if text is neither form.
+bool parse_digest(const std::string& text, ContigDigest& digest, bool& has_counts) {
+    std::string hex = text;
+    has_counts = false;
+    if (text.compare(0, 7, "Digest ") == 0) {
+        unsigned long long n_contigs, total_length;
+        char buf[33];
+        if (sscanf(text.c_str(), "Digest %32s (%llu contigs, %llu bases)", buf, &n_contigs,
+                   &total_length) == 3) {
+            digest.n_contigs = n_contigs;
+            digest.total_length = total_length;
+            has_counts = true;
+        }
+        hex = text.substr(7, 32);
+    }
+    if (hex.size() != 32 || hex.find_first_not_of("0123456789abcdefABCDEF") != std::string::npos) {
+        return false;
+    }
+    digest.hash_hi = strtoull(hex.substr(0, 16).c_str(), NULL, 16);
+    digest.hash_lo = strtoull(hex.substr(16).c_str(), NULL, 16);
+    return true;
+}
+
+// Reference digest for a verify run. ref is one of
+//   - a digest file written by contig_digest (its output redirected to a file),
+//   - a solution file, which is digested here,
+//   - the 32 hex digits of a digest.
+// Stored digests must have been made with the same canonical setting.
+ContigDigest reference_digest(const std::string& ref, bool canonical, bool& has_counts) {
+    ContigDigest digest;
+    std::ifstream fin(ref);
+    if (fin.is_open()) {
+        std::string line;
+        std::getline(fin, line);
+        if (line.compare(0, 7, "Digest ") == 0 && parse_digest(line, digest, has_counts)) {
+            return digest;
+        }
+        fin.close();
+        has_counts = true;
+        return digest_file(ref, canonical);
+    }
+    if (!parse_digest(ref, digest, has_counts)) {
+        throw std::runtime_error("reference_digest: " + ref + " is neither a file nor a digest");
+    }
+    return digest;
+}
+
+// Whether ref can be passed to reference_digest: a file that opens, or a digest.
+bool reference_available(const std::string& ref) {
+    ContigDigest digest;
+    bool has_counts;
+    return std::ifstream(ref).is_open() || parse_digest(ref, digest, has_counts);
+}
+
+// Compare against a reference digest, ignoring the counts if it has none.
+bool digest_matches(const ContigDigest& digest, const ContigDigest& ref, bool has_counts) {
+    if (has_counts) {
+        return digest == ref;
+    }
+    return digest.hash_lo == ref.hash_lo && digest.hash_hi == ref.hash_hi;
+}
@@ -1,10 +1,17 @@
 #pragma once
 #include <upcxx/upcxx.hpp>
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
 #include <unordered_map>
 #include <string>
 #include <vector>
 #include <utility>
 #include "kmer_t.hpp"
+#include "kmer_index.hpp"
+#include "kmer_table.hpp"
+#include "progress_thread.hpp"
 
 // DistributedHashMap is a nontrivial implementation that partitions 
 // the key-space by having each rank “own” a portion of the hash space.
@@ -12,16 +19,149 @@
 class DistributedHashMap {
 public:
   // Type aliases for clarity.
-  using local_map_type = std::unordered_map<std::string, kmer_pair>;
+  using local_map_type = EpochKmerTable;
   using kv_pair = std::pair<std::string, kmer_pair>;
-  using batch_type = std::vector<kv_pair>;
+  // Only the value travels; the key is needed for routing alone.
+  using batch_type = std::vector<kmer_pair>;
+
+  // A record tagged with its owner rank, for two-level (node-level) routing.
+  // Trivially copyable, so it can sit in the shared segment.
+  struct routed_kmer {
+    int owner;
+    kmer_pair entry;
+  };
+  using routed_batch = std::vector<routed_kmer>;
+
+  // Reply to a claiming lookup (canonical traversal).
+  struct claim_result {
+    kmer_pair entry;
+    uint64_t claimed_by;
+    bool found;
+  };
+
+  // Per-rank storage: the mutable map used while inserting, and the
+  // read-only index that replaces it after freeze(). Both keep the walker
+  // claims of canonical traversal next to their entries. conflicts counts
+  // inserts that hit an entry with the same key but other extensions.
+  struct local_store {
+    local_map_type map;
+    FrozenKmerIndex index;
+    bool frozen = false;
+    size_t conflicts = 0;
+
+    const kmer_pair *find(const std::string &key) const {
+      pkmer_t kmer(key);
+      return frozen ? index.find(kmer) : map.find(kmer);
+    }
+
+    void insert(const kmer_pair &entry) {
+      if (!map.insert(entry)) {
+        conflicts++;
+      }
+    }
+
+    // Find key and claim it for walker unless another walker already has.
+    claim_result claim(const std::string &key, uint64_t walker) {
+      pkmer_t kmer(key);
+      uint64_t owner = 0;
+      const kmer_pair *entry = frozen ? index.claim(kmer, walker, owner)
+                                      : map.claim(kmer, walker, owner);
+      if (entry == nullptr) {
+        return {kmer_pair(), 0, false};
+      }
+      return {*entry, owner, true};
+    }
+  };
+
+  // Where a rank publishes its records for hierarchical insertion: shared
+  // segment arrays, grouped by destination node, so that node d's records are
+  // records[node_start[d] .. node_start[d + 1]). Aggregators on the same node
+  // read them in place through global_ptr::local(). The arrays are kept from
+  // one insert_all() to the next and only grow, like the local table.
+  struct shared_records {
+    upcxx::global_ptr<routed_kmer> records;
+    upcxx::global_ptr<uint64_t> node_start;
+  };
   
 private:
   // Each rank holds a local copy, wrapped in a UPC++ dist_object.
-  upcxx::dist_object<local_map_type> local_map;
+  upcxx::dist_object<local_store> local_map;
+  // Hierarchical insertion: this rank's published records, and the records
+  // received from other nodes that still have to be scattered on this node.
+  upcxx::dist_object<shared_records> published;
+  size_t published_capacity_ = 0;
+  upcxx::dist_object<routed_batch> inbox;
   size_t table_size_;
   int rank_id_;
   int world_size_;
+  // Node layout, used only when hierarchical_ is set.
+  bool hierarchical_;
+  int node_size_;
+  int n_nodes_;
+  int node_id_;
+  // Optional helper thread that services RPCs; barriers must go through it.
+  ProgressThread *progress_ = nullptr;
+  // Remote lookup count and total wait time (seconds), for latency reporting.
+  size_t remote_lookups_ = 0;
+  double remote_lookup_time_ = 0.0;
+  // Store each k-mer once, under the smaller of itself and its reverse complement.
+  bool canonical_ = false;
+
+  // Guards writes to this rank's stores, which a progress thread may run
+  // concurrently with the main thread. Taken per chunk of a batch, never for
+  // a whole batch, so an RPC handler on the progress thread only ever waits
+  // for a bounded amount of work.
+  static std::mutex &store_mutex() {
+    static std::mutex mutex;
+    return mutex;
+  }
+
+  // Entries inserted per hold of store_mutex().
+  static constexpr size_t insert_chunk = 4096;
+
+  // Insert a batch into store, releasing the lock between chunks.
+  static void insert_entries(local_store &store, const batch_type &batch) {
+    for (size_t begin = 0; begin < batch.size(); begin += insert_chunk) {
+      size_t end = std::min(batch.size(), begin + insert_chunk);
+      std::lock_guard<std::mutex> lock(store_mutex());
+      for (size_t i = begin; i < end; i++) {
+        store.insert(batch[i]);
+      }
+    }
+  }
+
+  // Barrier that also works while the master persona is on a progress thread.
+  void sync(const upcxx::team &team = upcxx::world()) {
+    if (progress_ != nullptr) {
+      progress_->barrier(team);
+    } else {
+      upcxx::barrier(team);
+    }
+  }
+
+  // Sum over all ranks that also works while a progress thread holds the
+  // master persona.
+  size_t sum_all(size_t value) {
+    if (progress_ != nullptr) {
+      return progress_->reduce_all(value, upcxx::op_fast_add);
+    }
+    return upcxx::reduce_all(value, upcxx::op_fast_add).wait();
+  }
+
+  // Canonical mode: two input k-mers with the same canonical form but other
+  // extensions would silently replace each other, so stop here instead.
+  // Identical duplicates (the same k-mer read on both strands) are fine.
+  void check_conflicts() {
+    if (!canonical_) {
+      return;
+    }
+    size_t conflicts = sum_all(local_map->conflicts);
+    if (conflicts > 0) {
+      throw std::runtime_error("Error: " + std::to_string(conflicts) +
+          " k-mers share their canonical form with a k-mer that has other extensions; "
+          "this input cannot be assembled with --canonical.");
+    }
+  }
 
   // Partition function: each rank owns keys whose hash falls in its interval.
   // (For simplicity, we still use key % world_size.)
@@ -29,36 +169,219 @@ private:
     return std::hash<std::string>{}(key) % world_size_;
   }
 
-  // Local insertion: add a key-value pair to the local hash table.
-  void insert_locally(const std::string &key, const kmer_pair &value) {
-    (*local_map)[key] = value;
+  // Key and stored value for an input k-mer. In canonical mode the key is the
+  // canonical k-mer and the value is oriented to match it.
+  kv_pair make_entry(const kmer_pair &item) const {
+    if (!canonical_) {
+      return {item.kmer_str(), item};
+    }
+    pkmer_t canon = item.kmer.canonical();
+    return {canon.get(), (canon == item.kmer) ? item : item.revcomp()};
+  }
+
+  // Look up a key exactly as stored.
+  bool find_key(const std::string &key, kmer_pair &result) {
+    int target = get_target_rank(key);
+    if(target == rank_id_){
+      const kmer_pair *entry = local_map->find(key);
+      if(entry != nullptr){
+        result = *entry;
+        return true;
+      }
+      return false;
+    }
+    else {
+      auto wait_start = std::chrono::high_resolution_clock::now();
+      auto fut = upcxx::rpc(target,
+         [](upcxx::dist_object<local_store> &lmap, const std::string &key) -> upcxx::future<kmer_pair> {
+             const kmer_pair *entry = lmap->find(key);
+             return upcxx::make_future((entry != nullptr) ? *entry : kmer_pair());
+         },
+         local_map, key);
+      kmer_pair found = fut.wait();
+      remote_lookup_time_ += std::chrono::duration<double>(
+          std::chrono::high_resolution_clock::now() - wait_start).count();
+      remote_lookups_++;
+      if(!found.kmer_str().empty()){
+         result = found;
+         return true;
+      }
+      return false;
+    }
+  }
+
+  // Local insertion: add a batch of key-value pairs to the local hash table.
+  void insert_batch_locally(const batch_type &batch) {
+    insert_entries(*local_map, batch);
   }
 
   // Remote insertion: insert a batch of updates via a single RPC.
   void insert_batch_remote(int target_rank, const batch_type &batch) {
     upcxx::rpc(target_rank,
-      [](upcxx::dist_object<local_map_type> &lmap, const batch_type &batch) {
-        for (const auto &entry : batch) {
-          (*lmap)[entry.first] = entry.second;
-        }
+      [](upcxx::dist_object<local_store> &lmap, const batch_type &batch) {
+        insert_entries(*lmap, batch);
       },
       local_map, batch).wait();
   }
 
+  // Two-level insert. Records for node d are gathered by this node's
+  // aggregator for d straight from the shared segment of every rank on the
+  // node, and sent to node d in one message; the receiving rank then
+  // scatters them to their owners on its node. Per-rank message counts
+  // scale with the node count, not the rank count.
+  void insert_all_hierarchical(const std::vector<kmer_pair> &items) {
+    upcxx::team &node = upcxx::local_team();
+
+    // Stage 1: publish this rank's records in the shared segment, grouped by
+    // destination node (counting sort on the node id).
+    routed_batch routed;
+    routed.reserve(items.size());
+    std::vector<uint64_t> start(n_nodes_ + 1, 0);
+    for (const auto &item : items) {
+      kv_pair entry = make_entry(item);
+      int owner = get_target_rank(entry.first);
+      routed.push_back({owner, entry.second});
+      start[owner / node_size_ + 1]++;
+    }
+    for (int d = 0; d < n_nodes_; d++) {
+      start[d + 1] += start[d];
+    }
+    if (routed.size() > published_capacity_ || published->records.is_null()) {
+      if (!published->records.is_null()) {
+        upcxx::delete_array(published->records);
+      }
+      published_capacity_ = std::max<size_t>(routed.size(), 1);
+      published->records = upcxx::new_array<routed_kmer>(published_capacity_);
+    }
+    if (published->node_start.is_null()) {
+      published->node_start = upcxx::new_array<uint64_t>(n_nodes_ + 1);
+    }
+    std::copy(start.begin(), start.end(), published->node_start.local());
+    routed_kmer *records = published->records.local();
+    for (const auto &record : routed) {
+      records[start[record.owner / node_size_]++] = record;
+    }
+    routed_batch().swap(routed);
+    sync(node);
+
+    // Stage 2: one message per (source node, destination node) pair. The
+    // aggregator copies node d's slice out of each peer's shared arrays; the
+    // receiver on node d is chosen by source node to spread the load.
+    std::vector<upcxx::future<shared_records>> peer_futs;
+    for (int p = 0; p < node.rank_n(); p++) {
+      peer_futs.push_back(published.fetch(node[p]));
+    }
+    std::vector<shared_records> peers;
+    for (auto &fut : peer_futs) {
+      peers.push_back(fut.wait());
+    }
+    upcxx::future<> transfers = upcxx::make_future();
+    for (int d = node.rank_me(); d < n_nodes_; d += node_size_) {
+      routed_batch batch;
+      for (const auto &peer : peers) {
+        const uint64_t *peer_start = peer.node_start.local();
+        const routed_kmer *peer_records = peer.records.local();
+        batch.insert(batch.end(), peer_records + peer_start[d], peer_records + peer_start[d + 1]);
+      }
+      if (batch.empty()) {
+        continue;
+      }
+      if (d == node_id_) {
+        std::lock_guard<std::mutex> lock(store_mutex());
+        inbox->insert(inbox->end(), batch.begin(), batch.end());
+        continue;
+      }
+      int receiver = d * node_size_ + node_id_ % node_size_;
+      auto fut = upcxx::rpc(receiver,
+        [](upcxx::dist_object<routed_batch> &inbox, const routed_batch &batch) {
+          std::lock_guard<std::mutex> lock(store_mutex());
+          inbox->insert(inbox->end(), batch.begin(), batch.end());
+        },
+        inbox, batch);
+      transfers = upcxx::when_all(transfers, fut);
+    }
+    transfers.wait();
+    // Every aggregator is done reading the shared arrays, which may now be
+    // refilled (or grown) by the next insert_all().
+    sync();
+
+    // Stage 3: scatter everything received to the owners on this node.
+    std::unordered_map<int, batch_type> batches;
+    for (const auto &record : *inbox) {
+      batches[record.owner].push_back(record.entry);
+    }
+    routed_batch().swap(*inbox);
+    for (const auto &pair : batches) {
+      if (pair.first == rank_id_) {
+        insert_batch_locally(pair.second);
+      } else {
+        insert_batch_remote(pair.first, pair.second);
+      }
+    }
+    sync();
+    check_conflicts();
+  }
+
 public:
   // Constructor. Each rank initializes its local hash table.
-  DistributedHashMap(size_t table_size, int rank_id, int world_size)
-      : table_size_(table_size), rank_id_(rank_id), world_size_(world_size),
-        local_map({}) {}
+  // With hierarchical set, inserts are routed through per-node aggregators;
+  // this needs the same number of ranks on every node, numbered node by
+  // node, and falls back to direct inserts otherwise (or on a single node).
+  DistributedHashMap(size_t table_size, int rank_id, int world_size, bool hierarchical = false)
+      : local_map({}), published({}), inbox({}), table_size_(table_size), rank_id_(rank_id),
+        world_size_(world_size), hierarchical_(false) {
+    node_size_ = upcxx::local_team().rank_n();
+    n_nodes_ = world_size_ / node_size_;
+    node_id_ = rank_id_ / node_size_;
+    if (hierarchical) {
+      // Every node must have the same size (the smallest equals the largest);
+      // only then does the node-by-node numbering check below imply a layout
+      // that all ranks agree on.
+      int min_size = upcxx::reduce_all(node_size_, upcxx::op_fast_min).wait();
+      int max_size = upcxx::reduce_all(node_size_, upcxx::op_fast_max).wait();
+      int blocked = (min_size == max_size && world_size_ % node_size_ == 0 &&
+                     upcxx::local_team()[0] == node_id_ * node_size_) ? 1 : 0;
+      blocked = upcxx::reduce_all(blocked, upcxx::op_fast_min).wait();
+      hierarchical_ = blocked && n_nodes_ > 1;
+    }
+  }
+
+  // Frees the shared segment arrays; must run before upcxx::finalize().
+  ~DistributedHashMap() {
+    if (!published->records.is_null()) {
+      upcxx::delete_array(published->records);
+    }
+    if (!published->node_start.is_null()) {
+      upcxx::delete_array(published->node_start);
+    }
+  }
+
+  DistributedHashMap(const DistributedHashMap &) = delete;
+  DistributedHashMap &operator=(const DistributedHashMap &) = delete;
+
+  // Whether inserts are actually routed through node aggregators.
+  bool hierarchical() const { return hierarchical_; }
+
+  // Route this map's barriers through a progress thread (nullptr to detach).
+  void set_progress_thread(ProgressThread *progress) { progress_ = progress; }
+
+  // Mean wall time of this rank's remote lookups, in microseconds.
+  double mean_remote_lookup_us() const {
+    return remote_lookups_ ? 1e6 * remote_lookup_time_ / remote_lookups_ : 0.0;
+  }
 
   // Batch insert: partition input items by owner and update with one RPC per target.
   void insert_all(const std::vector<kmer_pair> &items) {
+    if (hierarchical_) {
+      insert_all_hierarchical(items);
+      return;
+    }
     // Partition batch: map target_rank -> vector of key-value pairs.
     std::unordered_map<int, batch_type> batches;
     for (const auto &item : items) {
-      std::string key = item.kmer_str();
-      int target = get_target_rank(key);
-      batches[target].push_back({key, item});
+      kv_pair entry = make_entry(item);
+      int target = get_target_rank(entry.first);
+      batches[target].push_back(entry.second);
     }
     // Issue batch updates to each target.
     for (const auto &pair : batches) {
@@ -66,9 +389,7 @@ public:
       const batch_type &batch = pair.second;
       if (target == rank_id_) {
         // Insert locally.
-        for (const auto &entry : batch) {
-          insert_locally(entry.first, entry.second);
-        }
+        insert_batch_locally(batch);
       }
       else {
         // Insert remotely in one call.
@@ -76,39 +397,99 @@ public:
       }
     }
     // Synchronize so that all updates are visible.
-    upcxx::barrier();
+    sync();
+    check_conflicts();
   }
 
-  // Distributed find: look up a key on the owning rank.
+  // Distributed find: look up a key on the owning rank. In canonical mode
+  // the key may be in either orientation and so is the result.
   bool find(const std::string &key, kmer_pair &result) {
-    int target = get_target_rank(key);
-    if(target == rank_id_){
-      auto it = local_map->find(key);
-      if(it != local_map->end()){
-        result = it->second;
-        return true;
-      }
+    if (!canonical_) {
+      return find_key(key, result);
+    }
+    pkmer_t query(key);
+    pkmer_t canon = query.canonical();
+    kmer_pair entry;
+    if (!find_key(canon.get(), entry)) {
       return false;
     }
-    else {
-      auto fut = upcxx::rpc(target,
-         [](upcxx::dist_object<local_map_type> &lmap, const std::string &key) -> upcxx::future<kmer_pair> {
-             auto it = lmap->find(key);
-             return upcxx::make_future((it != lmap->end()) ? it->second : kmer_pair());
-         },
-         local_map, key);
-      kmer_pair found = fut.wait();
-      if(!found.kmer_str().empty()){
-         result = found;
-         return true;
-      }
+    result = (canon == query) ? entry : entry.revcomp();
+    return true;
+  }
+
+  // Canonical traversal: look up an oriented k-mer and claim it for walker
+  // (nonzero) unless another walker holds it. Returns false if absent;
+  // otherwise result is in the queried orientation and claimed_by is the
+  // walker holding the k-mer (equal to walker if this call claimed it).
+  bool find_and_claim(const pkmer_t &kmer, uint64_t walker, kmer_pair &result,
+                      uint64_t &claimed_by) {
+    pkmer_t canon = kmer.canonical();
+    std::string key = canon.get();
+    int target = get_target_rank(key);
+    claim_result reply;
+    if (target == rank_id_) {
+      std::lock_guard<std::mutex> lock(store_mutex());
+      reply = local_map->claim(key, walker);
+    } else {
+      auto wait_start = std::chrono::high_resolution_clock::now();
+      reply = upcxx::rpc(target,
+          [](upcxx::dist_object<local_store> &lmap, const std::string &key, uint64_t walker) {
+            std::lock_guard<std::mutex> lock(store_mutex());
+            return lmap->claim(key, walker);
+          },
+          local_map, key, walker).wait();
+      remote_lookup_time_ += std::chrono::duration<double>(
+          std::chrono::high_resolution_clock::now() - wait_start).count();
+      remote_lookups_++;
+    }
+    if (!reply.found) {
       return false;
     }
+    result = (canon == kmer) ? reply.entry : reply.entry.revcomp();
+    claimed_by = reply.claimed_by;
+    return true;
+  }
+
+  // Switch to canonical storage. Must be set on every rank before inserting.
+  void set_canonical(bool canonical) { canonical_ = canonical; }
+  bool canonical() const { return canonical_; }
+
+  // Start a new dataset of about table_size / 2 k-mers: empty the local
+  // stores (the table in O(1) by bumping its epoch, keeping its slots),
+  // grow the table if this dataset needs more room, and clear the stats.
+  // Collective, so no peer is still reading the previous dataset.
+  void reset(size_t table_size) {
+    sync();
+    table_size_ = table_size;
+    local_map->map.reset();
+    local_map->map.reserve(table_size_ / 2 / world_size_ + 1);
+    local_map->index.clear();
+    local_map->frozen = false;
+    local_map->conflicts = 0;
+    remote_lookups_ = 0;
+    remote_lookup_time_ = 0.0;
+    sync();
+  }
+
+  // Freeze: once all inserts are done, move the local entries into a
+  // read-only packed index. With release_table set the table's slots are
+  // freed; otherwise (batch mode) they are only emptied, and kept for the
+  // next dataset. Collective.
+  void freeze(bool release_table = true) {
+    local_map->index.build(local_map->map);
+    if (release_table) {
+      local_map->map = local_map_type();
+    } else {
+      local_map->map.reset();
+    }
+    local_map->frozen = true;
+    // Peers may not look anything up here until the index is built.
+    sync();
   }
 
   // Process requests and synchronize.
   void process_requests() {
     upcxx::progress(upcxx::progress_level::user);
-    upcxx::barrier();
+    sync();
   }
 };
@@ -0,0 +1,177 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <unordered_set>
+#include <vector>
+
+// -------------------------------------------------------------------------
+// kmer_gen: synthetic dataset generator.
+//   Builds random contigs whose k-mers are all distinct, then writes
+//     <prefix>.txt           - one "KMER BF" line per k-mer, shuffled
+//     <prefix>_solution.txt  - the contigs, sorted (same as the reference sets)
+//   so that any K, dataset size and contig-length distribution can be
+//   assembled and checked without the CFS datasets. K-mers are unique up to
+//   reverse complement, and -r writes a fraction of the lines as read from
+//   the other strand (double-stranded input for kmer_hash --canonical).
+// -------------------------------------------------------------------------
+
+static const char BASES[4] = {'A', 'C', 'G', 'T'};
+
+struct gen_options {
+    int k = 19;
+    size_t n_contigs = 1000;
+    size_t mean_len = 1000;
+    std::string dist = "exp";
+    unsigned long seed = 1;
+    double reverse_fraction = 0.0;
+    std::string prefix;
+};
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [-k K] [-n contigs] [-l mean_length] [-d fixed|uniform|exp] [-s seed] "
+            "[-r reverse_fraction] prefix\n"
+            "  Writes prefix.txt and prefix_solution.txt.\n",
+            prog);
+}
+
+static char complement(char base) {
+    switch (base) {
+    case 'A': return 'T';
+    case 'C': return 'G';
+    case 'G': return 'C';
+    case 'T': return 'A';
+    default: return base;
+    }
+}
+
+static std::string revcomp(const std::string &seq) {
+    std::string rc(seq.rbegin(), seq.rend());
+    for (auto &base : rc) {
+        base = complement(base);
+    }
+    return rc;
+}
+
+// The smaller of a k-mer and its reverse complement.
+static std::string canonical(const std::string &kmer) { return std::min(kmer, revcomp(kmer)); }
+
+// Draw a contig length (in bases, always >= k) from the requested distribution.
+static size_t draw_length(const gen_options &opt, std::mt19937_64 &rng) {
+    size_t k = opt.k;
+    size_t mean = std::max(opt.mean_len, k);
+    if (opt.dist == "fixed") {
+        return mean;
+    }
+    if (opt.dist == "uniform") {
+        std::uniform_int_distribution<size_t> len(k, 2 * mean - k);
+        return len(rng);
+    }
+    // "exp": k plus an exponential tail, mimicking the long-tailed real sets.
+    std::exponential_distribution<double> tail(1.0 / std::max<double>(1.0, mean - k));
+    return k + (size_t)tail(rng);
+}
+
+int main(int argc, char **argv) {
+    gen_options opt;
+    int c;
+    while ((c = getopt(argc, argv, "k:n:l:d:s:r:")) != -1) {
+        switch (c) {
+        case 'k': opt.k = atoi(optarg); break;
+        case 'n': opt.n_contigs = strtoull(optarg, NULL, 10); break;
+        case 'l': opt.mean_len = strtoull(optarg, NULL, 10); break;
+        case 'd': opt.dist = optarg; break;
+        case 's': opt.seed = strtoul(optarg, NULL, 10); break;
+        case 'r': opt.reverse_fraction = atof(optarg); break;
+        default: usage(argv[0]); return 1;
+        }
+    }
+    if (optind != argc - 1 || opt.k < 2 || opt.reverse_fraction < 0.0 ||
+        opt.reverse_fraction > 1.0 ||
+        (opt.dist != "fixed" && opt.dist != "uniform" && opt.dist != "exp")) {
+        usage(argv[0]);
+        return 1;
+    }
+    opt.prefix = argv[optind];
+
+    std::mt19937_64 rng(opt.seed);
+    std::uniform_int_distribution<int> base(0, 3);
+    std::bernoulli_distribution reverse(opt.reverse_fraction);
+
+    std::unordered_set<std::string> seen;
+    std::vector<std::string> contigs;
+    std::vector<std::string> lines;
+    contigs.reserve(opt.n_contigs);
+
+    const int max_tries = 100;
+    while (contigs.size() < opt.n_contigs) {
+        size_t len = draw_length(opt, rng);
+        std::string contig;
+        contig.reserve(len);
+        for (int i = 0; i < opt.k; i++) {
+            contig += BASES[base(rng)];
+        }
+
+        // Palindromic k-mers (even K only) would be their own reverse complement.
+        if (seen.count(canonical(contig)) || contig == revcomp(contig)) {
+            continue;
+        }
+
+        // Extend one base at a time, retrying a few times when the new k-mer
+        // collides with one already used; give up and end the contig early
+        // otherwise. A contig must not repeat a k-mer or the walk would branch.
+        std::unordered_set<std::string> mine = {canonical(contig)};
+        while (contig.size() < len) {
+            bool extended = false;
+            for (int t = 0; t < max_tries && !extended; t++) {
+                char next = BASES[base(rng)];
+                std::string kmer = canonical(contig.substr(contig.size() - opt.k + 1) + next);
+                if (!seen.count(kmer) && !mine.count(kmer) && kmer != revcomp(kmer)) {
+                    mine.insert(kmer);
+                    contig += next;
+                    extended = true;
+                }
+            }
+            if (!extended) {
+                break;
+            }
+        }
+
+        size_t n = contig.size() - opt.k + 1;
+        for (size_t i = 0; i < n; i++) {
+            std::string kmer = contig.substr(i, opt.k);
+            char bwd = (i == 0) ? 'F' : contig[i - 1];
+            char fwd = (i + 1 == n) ? 'F' : contig[i + opt.k];
+            seen.insert(canonical(kmer));
+            if (reverse(rng)) {
+                lines.push_back(revcomp(kmer) + " " + complement(fwd) + complement(bwd));
+            } else {
+                lines.push_back(kmer + " " + bwd + fwd);
+            }
+        }
+        contigs.push_back(contig);
+    }
+
+    std::shuffle(lines.begin(), lines.end(), rng);
+    std::sort(contigs.begin(), contigs.end());
+
+    std::ofstream fout(opt.prefix + ".txt");
+    for (const auto &line : lines) {
+        fout << line << '\n';
+    }
+    fout.close();
+
+    std::ofstream fsol(opt.prefix + "_solution.txt");
+    for (const auto &contig : contigs) {
+        fsol << contig << '\n';
+    }
+    fsol.close();
+
+    fprintf(stderr, "Wrote %zu %d-mers in %zu contigs to %s.txt\n", lines.size(), opt.k,
+            contigs.size(), opt.prefix.c_str());
+    return 0;
+}
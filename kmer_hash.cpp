@@ -5,6 +5,7 @@
 #include <list>
 #include <numeric>
 #include <set>
+#include <unordered_map>
 #include <upcxx/upcxx.hpp>
 #include <vector>
 #include <fstream>
@@ -13,11 +14,14 @@
 #include "kmer_t.hpp"
 #include "read_kmers.hpp"
 #include "butil.hpp"
+#include "contig_digest.hpp"
 
 // -------------------------------------------------------------------------
 // Function: initialize_kmers
 //   Splits the local k-mers into a batch and inserts them in one call.
-//   Also collects start nodes (k-mers with backward extension 'F').
+//   Also collects start nodes (k-mers with backward extension 'F'). In canonical
+//   mode, k-mers with forward extension 'F' are contig ends read on the other
+//   strand and are collected too, reverse-complemented.
 void initialize_kmers(DistributedHashMap &hashmap, 
                       const std::vector<kmer_pair> &kmers, 
                       std::vector<kmer_pair> &start_nodes) {
@@ -28,8 +32,11 @@ void initialize_kmers(DistributedHashMap &hashmap,
         if (kmer.backwardExt() == 'F') {
             start_nodes.push_back(kmer);
         }
+        if (hashmap.canonical() && kmer.forwardExt() == 'F') {
+            start_nodes.push_back(kmer.revcomp());
+        }
     }
-    upcxx::barrier();
+    hashmap.process_requests();
 }
 
 // -------------------------------------------------------------------------
@@ -54,6 +61,102 @@ std::list<std::list<kmer_pair>> assemble_contigs(DistributedHashMap &hashmap,
     return contigs;
 }
 
+// Contig halves sent to the walker that finishes the contig, keyed by sender.
+using contig_halves = std::unordered_map<uint64_t, std::vector<kmer_pair>>;
+
+// -------------------------------------------------------------------------
+// Function: orient_canonical
+//   Flips a contig to the other strand if its reverse complement is smaller.
+void orient_canonical(std::list<kmer_pair> &contig) {
+    std::string seq = extract_contig(contig);
+    if (revcomp_contig(seq) < seq) {
+        contig.reverse();
+        for (auto &kmer : contig) {
+            kmer = kmer.revcomp();
+        }
+    }
+}
+
+// -------------------------------------------------------------------------
+// Function: assemble_contigs_canonical
+//   Canonical mode: both ends of every contig are seeds, so each contig is
+//   walked from both ends at once. Walkers claim k-mers as they go and stop
+//   where they meet; the walker with the smaller id keeps its half and
+//   appends the other walker's half, which is sent to it. A walker that
+//   reaches the far end unopposed has the whole contig. Contigs are returned
+//   in canonical orientation.
+std::list<std::list<kmer_pair>> assemble_contigs_canonical(DistributedHashMap &hashmap,
+                                                           const std::vector<kmer_pair> &start_nodes,
+                                                           upcxx::dist_object<contig_halves> &halves) {
+    std::list<std::list<kmer_pair>> contigs;
+    // Halves this rank completes: (partner walker, own half).
+    std::vector<std::pair<uint64_t, std::list<kmer_pair>>> waiting;
+    upcxx::future<> sends = upcxx::make_future();
+
+    const uint64_t rank_tag = uint64_t(upcxx::rank_me()) << 32;
+    for (size_t i = 0; i < start_nodes.size(); i++) {
+        const uint64_t walker = rank_tag | (i + 1);
+        std::list<kmer_pair> half;
+        uint64_t partner = 0;
+        pkmer_t next = start_nodes[i].kmer;
+        while (true) {
+            kmer_pair found;
+            uint64_t holder;
+            if (!hashmap.find_and_claim(next, walker, found, holder)) {
+                throw std::runtime_error("Error: k-mer not found in Distributed HashMap.");
+            }
+            if (holder != walker) {
+                partner = holder;
+                break;
+            }
+            half.push_back(found);
+            if (found.forwardExt() == 'F') {
+                break;
+            }
+            next = found.next_kmer();
+        }
+
+        if (half.empty()) {
+            // The walker from the other end got here first.
+            continue;
+        }
+        if (partner == 0) {
+            contigs.push_back(std::move(half));
+        } else if (walker < partner) {
+            waiting.push_back({partner, std::move(half)});
+        } else {
+            auto fut = upcxx::rpc(int(partner >> 32),
+                [](upcxx::dist_object<contig_halves> &halves, uint64_t sender,
+                   const std::vector<kmer_pair> &half) {
+                    (*halves)[sender] = half;
+                },
+                halves, walker, std::vector<kmer_pair>(half.begin(), half.end()));
+            sends = upcxx::when_all(sends, fut);
+        }
+    }
+    sends.wait();
+    hashmap.process_requests();
+
+    // The partner's half runs from the far end inwards on the other strand.
+    for (auto &entry : waiting) {
+        auto it = halves->find(entry.first);
+        if (it == halves->end()) {
+            throw std::runtime_error("Error: missing contig half from partner walker.");
+        }
+        std::list<kmer_pair> contig = std::move(entry.second);
+        for (auto rit = it->second.rbegin(); rit != it->second.rend(); ++rit) {
+            contig.push_back(rit->revcomp());
+        }
+        contigs.push_back(std::move(contig));
+    }
+    halves->clear();
+
+    for (auto &contig : contigs) {
+        orient_canonical(contig);
+    }
+    return contigs;
+}
+
 // -------------------------------------------------------------------------
 // Function: output_results
 //   Prints metrics in the same format as the starter code and writes contigs.
@@ -79,47 +182,146 @@ void output_results(const std::list<std::list<kmer_pair>> &contigs,
 }
 
 // -------------------------------------------------------------------------
-// Main: Distributed genome assembler using a scalable distributed hash table.
+// Function: verify_results
+//   Digests the local contigs, combines the digests of all ranks and compares
+//   against a reference (if given): a solution file, a digest file written by
+//   contig_digest, or the 32 hex digits of a digest. With a stored digest the
+//   check is a single comparison. Returns true on match. Canonical runs emit
+//   canonically oriented contigs, so a solution file is digested the same way.
+bool verify_results(const std::list<std::list<kmer_pair>> &contigs,
+                    const std::string &solution_fname, bool canonical) {
+    ContigDigest local_digest;
+    for (const auto &contig : contigs) {
+        local_digest.add(extract_contig(contig));
+    }
+    ContigDigest digest = upcxx::reduce_all(local_digest, op_digest_add()).wait();
+
+    BUtil::print("Digest %s (%llu contigs, %llu bases)\n", digest.hash_str().c_str(),
+                 (unsigned long long)digest.n_contigs, (unsigned long long)digest.total_length);
+    if (solution_fname.empty()) {
+        return true;
+    }
+
+    // Only rank 0 reads the reference (main has checked that it can); the
+    // verdict is broadcast to everyone.
+    bool match = false;
+    if (upcxx::rank_me() == 0) {
+        bool has_counts;
+        ContigDigest reference = reference_digest(solution_fname, canonical, has_counts);
+        match = digest_matches(digest, reference, has_counts);
+    }
+    match = upcxx::broadcast(match, 0).wait();
+    BUtil::print("%s: %s\n", match ? "PASSED" : "FAILED", solution_fname.c_str());
+    return match;
+}
+
 // -------------------------------------------------------------------------
-int main(int argc, char **argv) {
-    upcxx::init();
+// Function: report_bench
+//   Prints one CSV row of phase times (slowest rank per phase) and the mean remote
+//   lookup latency over ranks (microseconds) for the scaling driver:
+//   BENCH,ranks,kmers,read,insert,assembly,total,lookup_us
+void report_bench(int world_size, size_t n_kmers, double read_time, double insert_time,
+                  double assembly_time, double total_time, double lookup_us) {
+    read_time = upcxx::reduce_all(read_time, upcxx::op_fast_max).wait();
+    insert_time = upcxx::reduce_all(insert_time, upcxx::op_fast_max).wait();
+    assembly_time = upcxx::reduce_all(assembly_time, upcxx::op_fast_max).wait();
+    total_time = upcxx::reduce_all(total_time, upcxx::op_fast_max).wait();
+    lookup_us = upcxx::reduce_all(lookup_us, upcxx::op_fast_add).wait() / world_size;
+    BUtil::print("BENCH,%d,%lu,%lf,%lf,%lf,%lf,%lf\n", world_size, n_kmers, read_time, insert_time,
+                 assembly_time, total_time, lookup_us);
+}
 
-    if(argc < 2){
-        BUtil::print("Usage: srun -N nodes -n ranks ./kmer_hash kmer_file [verbose|test [prefix]]\n");
-        upcxx::finalize();
-        exit(1);
+// -------------------------------------------------------------------------
+// Optional --flags; they may appear anywhere after the program name.
+struct run_flags {
+    bool freeze = false;           // --freeze: switch to a read-only packed index after insertion
+    bool hierarchical = false;     // --hierarchical: route inserts through per-node aggregators
+    bool progress_thread = false;  // --progress-thread: service RPCs on a helper thread
+    bool canonical = false;        // --canonical: strand-independent storage, two-ended walks
+    bool manifest = false;         // --manifest: the input file lists several datasets
+};
+
+// Function: parse_flags
+//   Removes the recognized flags from args. Returns false on an unknown flag.
+bool parse_flags(std::vector<std::string> &args, run_flags &flags) {
+    std::vector<std::string> positional;
+    for (const auto &arg : args) {
+        if (arg == "--freeze") {
+            flags.freeze = true;
+        } else if (arg == "--hierarchical") {
+            flags.hierarchical = true;
+        } else if (arg == "--progress-thread") {
+            flags.progress_thread = true;
+        } else if (arg == "--canonical") {
+            flags.canonical = true;
+        } else if (arg == "--manifest") {
+            flags.manifest = true;
+        } else if (arg.compare(0, 2, "--") == 0) {
+            return false;
+        } else {
+            positional.push_back(arg);
+        }
     }
-    
-    std::string kmer_fname = std::string(argv[1]);
-    std::string run_type = (argc >= 3) ? std::string(argv[2]) : "";
-    std::string test_prefix = "test";
-    if(run_type == "test" && argc >= 4){
-        test_prefix = std::string(argv[3]);
+    args.swap(positional);
+    return true;
+}
+
+// -------------------------------------------------------------------------
+// One input of a run: a k-mer file, its K and (optionally) its solution.
+struct dataset {
+    std::string kmer_fname;
+    int k;
+    std::string solution_fname;
+};
+
+// Function: read_manifest
+//   Reads a batch manifest with one dataset per line: "kmer_file K [solution_file]".
+//   Blank lines and lines starting with '#' are skipped.
+std::vector<dataset> read_manifest(const std::string &fname) {
+    std::ifstream fin(fname);
+    if (!fin.is_open()) {
+        throw std::runtime_error("read_manifest: could not open " + fname);
     }
-    
-    int ks = kmer_size(kmer_fname);
-    if(ks != KMER_LEN){
-        throw std::runtime_error("Error: " + kmer_fname + " contains " + std::to_string(ks) +
-            "-mers, while this binary is compiled for " + std::to_string(KMER_LEN) +
-            "-mers. Modify packing.hpp and recompile.");
+    std::vector<dataset> datasets;
+    std::string line;
+    while (std::getline(fin, line)) {
+        std::istringstream fields(line);
+        dataset ds;
+        if (!(fields >> ds.kmer_fname) || ds.kmer_fname[0] == '#') {
+            continue;
+        }
+        if (!(fields >> ds.k)) {
+            throw std::runtime_error("read_manifest: missing K for " + ds.kmer_fname + " in " + fname);
+        }
+        fields >> ds.solution_fname;
+        datasets.push_back(ds);
     }
-    
-    size_t n_kmers = line_count(kmer_fname);
-    // Load factor of 0.5 implies table size = n_kmers*2.
-    size_t hash_table_size = n_kmers * 2;
-    
+    return datasets;
+}
+
+// -------------------------------------------------------------------------
+// Function: run_dataset
+//   Resets the table, then reads, inserts and assembles one dataset and reports
+//   its timings in the requested run type. Returns false if verify fails.
+bool run_dataset(DistributedHashMap &hashmap, ProgressThread &progress,
+                 upcxx::dist_object<contig_halves> &halves, const dataset &ds,
+                 const std::string &run_type, const std::string &test_prefix,
+                 const run_flags &flags) {
     int rank_id = upcxx::rank_me();
     int world_size = upcxx::rank_n();
+
+    size_t n_kmers = line_count(ds.kmer_fname);
+    // Load factor of 0.5 implies table size = n_kmers*2.
+    size_t hash_table_size = n_kmers * 2;
     
     if(run_type == "verbose"){
         BUtil::print("Initializing hash table of size %lu for %lu kmers.\n", hash_table_size, n_kmers);
     }
-    
-    // Create our scalable distributed hash map.
-    DistributedHashMap hashmap(hash_table_size, rank_id, world_size);
+    hashmap.reset(hash_table_size);
     
     // Read the k-mers (each rank gets a portion).
-    std::vector<kmer_pair> kmers = read_kmers(kmer_fname, world_size, rank_id);
+    auto read_start_time = std::chrono::high_resolution_clock::now();
+    std::vector<kmer_pair> kmers = read_kmers(ds.kmer_fname, world_size, rank_id);
     if(run_type == "verbose"){
         BUtil::print("Finished reading kmers.\n");
     }
@@ -128,25 +330,164 @@ int main(int argc, char **argv) {
     // Timing: begin insertion.
     auto start_time = std::chrono::high_resolution_clock::now();
     std::vector<kmer_pair> start_nodes;
+    progress.start();
     initialize_kmers(hashmap, kmers, start_nodes);
+    progress.stop();
+    if(flags.freeze){
+        // In a batch the table's slots are kept for the next dataset.
+        hashmap.freeze(!flags.manifest);
+    }
     auto insert_time = std::chrono::high_resolution_clock::now();
     
     // Assemble contigs using distributed lookups.
-    auto contigs = assemble_contigs(hashmap, start_nodes);
-    upcxx::barrier();
+    progress.start();
+    auto contigs = flags.canonical ? assemble_contigs_canonical(hashmap, start_nodes, halves)
+                                   : assemble_contigs(hashmap, start_nodes);
+    hashmap.process_requests();
+    progress.stop();
     auto end_time = std::chrono::high_resolution_clock::now();
     
+    double read_duration = std::chrono::duration<double>(start_time - read_start_time).count();
     double insert_duration = std::chrono::duration<double>(insert_time - start_time).count();
     double assembly_duration = std::chrono::duration<double>(end_time - insert_time).count();
     double total_duration = std::chrono::duration<double>(end_time - start_time).count();
     
-    if(run_type != "test"){
+    bool verified = true;
+    if(run_type == "test"){
+        output_results(contigs, test_prefix, rank_id, insert_duration, assembly_duration, total_duration);
+    } else if(run_type == "bench"){
+        report_bench(world_size, n_kmers, read_duration, insert_duration, assembly_duration,
+                     total_duration, hashmap.mean_remote_lookup_us());
+    } else {
         BUtil::print("Finished inserting in %lf sec\n", insert_duration);
         BUtil::print("Assembled in %lf total\n", total_duration);
+        if(run_type == "verbose"){
+            double lookup_us = upcxx::reduce_all(hashmap.mean_remote_lookup_us(),
+                                                 upcxx::op_fast_add).wait() / world_size;
+            BUtil::print("Mean remote lookup latency %lf us\n", lookup_us);
+        }
+        if(run_type == "verify"){
+            verified = verify_results(contigs, ds.solution_fname, flags.canonical);
+        }
+    }
+    return verified;
+}
+
+// -------------------------------------------------------------------------
+// Main: Distributed genome assembler using a scalable distributed hash table.
+//   With --manifest, the datasets listed in the manifest are processed one
+//   after another in the same job, reusing the runtime and the hash table.
+// -------------------------------------------------------------------------
+int main(int argc, char **argv) {
+    upcxx::init();
+
+    std::vector<std::string> args(argv + 1, argv + argc);
+    run_flags flags;
+    if(!parse_flags(args, flags) || args.empty()){
+        BUtil::print("Usage: srun -N nodes -n ranks ./kmer_hash kmer_file|manifest_file [verbose|test [prefix]|verify [solution_file|digest]|bench] [--freeze] [--hierarchical] [--progress-thread] [--canonical] [--manifest]\n");
+        upcxx::finalize();
+        exit(1);
+    }
+    if(flags.progress_thread && !ProgressThread::available()){
+        BUtil::print("--progress-thread needs a UPC++ build with UPCXX_THREADMODE=par.\n");
+        upcxx::finalize();
+        exit(1);
+    }
+    
+    std::string run_type = (args.size() >= 2) ? args[1] : "";
+    std::string test_prefix = "test";
+    if(run_type == "test" && args.size() >= 3){
+        test_prefix = args[2];
+    }
+    
+    std::vector<dataset> datasets;
+    if(flags.manifest){
+        datasets = read_manifest(args[0]);
     } else {
-        output_results(contigs, test_prefix, rank_id, insert_duration, assembly_duration, total_duration);
+        std::string solution_fname = (run_type == "verify" && args.size() >= 3) ? args[2] : "";
+        // Every rank checks the reference up front, so a bad path fails before
+        // the assembly and not in rank 0's verify_results.
+        if(!solution_fname.empty() && !reference_available(solution_fname)){
+            BUtil::print("Error: could not open %s, and it is not a digest.\n", solution_fname.c_str());
+            upcxx::finalize();
+            exit(1);
+        }
+        datasets.push_back({args[0], kmer_size(args[0]), solution_fname});
+        if(datasets[0].k != KMER_LEN){
+            throw std::runtime_error("Error: " + args[0] + " contains " +
+                std::to_string(datasets[0].k) + "-mers, while this binary is compiled for " +
+                std::to_string(KMER_LEN) + "-mers. Modify packing.hpp and recompile.");
+        }
+    }
+    
+    int rank_id = upcxx::rank_me();
+    int world_size = upcxx::rank_n();
+    
+    // Optional helper thread that keeps servicing RPCs during local compute.
+    ProgressThread progress(flags.progress_thread);
+
+    bool verified = true;
+    {
+        // Create our scalable distributed hash map; run_dataset sizes it per dataset.
+        // It lives in this block so that it (and its shared segment arrays) is
+        // destroyed before finalize.
+        DistributedHashMap hashmap(0, rank_id, world_size, flags.hierarchical);
+        if(run_type == "verbose" && flags.hierarchical){
+            BUtil::print("Hierarchical insertion %s.\n", hashmap.hierarchical() ? "enabled" :
+                         "unavailable for this rank layout, using direct inserts");
+        }
+        if(flags.progress_thread){
+            hashmap.set_progress_thread(&progress);
+        }
+        hashmap.set_canonical(flags.canonical);
+        upcxx::dist_object<contig_halves> halves({});
+    
+        int n_processed = 0;
+        auto batch_start_time = std::chrono::high_resolution_clock::now();
+        for(size_t i = 0; i < datasets.size(); i++){
+            const dataset &ds = datasets[i];
+            if(flags.manifest){
+                // A binary handles one K; the other binary picks up the rest of the
+                // manifest. This is not a failure, so verified is left alone.
+                if(ds.k != KMER_LEN){
+                    BUtil::print("Skipping %s: %d-mers, run it with kmer_hash_%d.\n",
+                                 ds.kmer_fname.c_str(), ds.k, ds.k);
+                    continue;
+                }
+                // A missing or mislabelled file fails this dataset (verified is
+                // cleared), not the whole batch.
+                if(!std::ifstream(ds.kmer_fname).is_open()){
+                    BUtil::print("Skipping %s: could not open file.\n", ds.kmer_fname.c_str());
+                    verified = false;
+                    continue;
+                }
+                if(run_type == "verify" && !ds.solution_fname.empty() &&
+                   !reference_available(ds.solution_fname)){
+                    BUtil::print("Skipping %s: could not open solution %s.\n",
+                                 ds.kmer_fname.c_str(), ds.solution_fname.c_str());
+                    verified = false;
+                    continue;
+                }
+                if(kmer_size(ds.kmer_fname) != ds.k){
+                    BUtil::print("Skipping %s: file does not contain %d-mers.\n",
+                                 ds.kmer_fname.c_str(), ds.k);
+                    verified = false;
+                    continue;
+                }
+                BUtil::print("Dataset %s\n", ds.kmer_fname.c_str());
+            }
+            std::string prefix = flags.manifest ? test_prefix + "_" + std::to_string(i) : test_prefix;
+            verified = run_dataset(hashmap, progress, halves, ds, run_type, prefix, flags) && verified;
+            n_processed++;
+        }
+        if(flags.manifest && run_type != "test"){
+            double batch_duration = std::chrono::duration<double>(
+                std::chrono::high_resolution_clock::now() - batch_start_time).count();
+            BUtil::print("Processed %d datasets in %lf sec\n", n_processed, batch_duration);
+        }
     }
     
-    upcxx::finalize();
-    return 0;
+    // Drops the progress thread's hold on the master persona before finalizing.
+    progress.finalize();
+    return verified ? 0 : 1;
 }
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "kmer_t.hpp"
+#include "kmer_table.hpp"
+
+// FrozenKmerIndex is a read-only replacement for the local hash table once
+// all inserts are done. Entries are stored as packed kmer_pairs in one array,
+// grouped by bucket, and a bucket table points at the start of each group.
+// Buckets are picked from a well-mixed hash of the packed k-mer (not its raw
+// leading bits, which canonical k-mers skew towards A/C), and there are
+// between n/2 and n of them, so a lookup is one bucket-table read plus a scan
+// of one or two entries on average. The per-entry overhead is 2-4 bytes of
+// bucket table, plus 8 bytes of walker claim once canonical traversal claims.
+class FrozenKmerIndex {
+public:
+  // Build from the live entries of table. The buffers of the previous build
+  // are reused, so rebuilding for each dataset of a batch does not reallocate
+  // unless the dataset is larger.
+  void build(const EpochKmerTable &table) {
+    // Largest power of two not above n, so buckets hold 1-2 entries on average.
+    size_t n = table.size();
+    bits_ = 0;
+    while ((size_t(2) << bits_) <= n) {
+      bits_++;
+    }
+    shift_ = 64 - bits_;
+
+    // Counting sort by bucket: bucket_start_[b] first holds the end of bucket
+    // b, and is moved down to its start as the bucket is filled.
+    size_t n_buckets = size_t(1) << bits_;
+    bucket_start_.assign(n_buckets + 1, 0);
+    table.for_each([this](const kmer_pair &entry) { bucket_start_[bucket(entry.kmer)]++; });
+    for (size_t b = 1; b < n_buckets; b++) {
+      bucket_start_[b] += bucket_start_[b - 1];
+    }
+    bucket_start_[n_buckets] = n;
+    entries_.resize(n);
+    table.for_each([this](const kmer_pair &entry) {
+      entries_[--bucket_start_[bucket(entry.kmer)]] = entry;
+    });
+    claims_.clear();
+  }
+
+  // Return the entry for key, or nullptr if absent.
+  const kmer_pair *find(const pkmer_t &key) const {
+    size_t i = locate(key);
+    return (i == npos) ? nullptr : &entries_[i];
+  }
+
+  // Claim the entry for key for walker (nonzero) unless another walker holds
+  // it. Returns the entry, or nullptr if absent; owner is set to the holder.
+  const kmer_pair *claim(const pkmer_t &key, uint64_t walker, uint64_t &owner) {
+    size_t i = locate(key);
+    if (i == npos) {
+      return nullptr;
+    }
+    if (claims_.size() != entries_.size()) {
+      claims_.assign(entries_.size(), 0);
+    }
+    if (claims_[i] == 0) {
+      claims_[i] = walker;
+    }
+    owner = claims_[i];
+    return &entries_[i];
+  }
+
+  size_t size() const { return entries_.size(); }
+
+  void clear() {
+    entries_.clear();
+    bucket_start_.clear();
+    claims_.clear();
+  }
+
+private:
+  std::vector<kmer_pair> entries_;
+  std::vector<uint32_t> bucket_start_;
+  std::vector<uint64_t> claims_;  // parallel to entries_, allocated on the first claim
+  int bits_ = 0;
+  int shift_ = 64;
+
+  static constexpr size_t npos = ~size_t(0);
+
+  // Position of key in entries_, or npos.
+  size_t locate(const pkmer_t &key) const {
+    if (entries_.empty()) {
+      return npos;
+    }
+    uint64_t b = bucket(key);
+    for (uint32_t i = bucket_start_[b]; i < bucket_start_[b + 1]; i++) {
+      if (entries_[i].kmer == key) {
+        return i;
+      }
+    }
+    return npos;
+  }
+
+  // Top bits_ bits of the Fibonacci-mixed k-mer hash (same mixing as EpochKmerTable).
+  uint64_t bucket(const pkmer_t &key) const {
+    return bits_ ? (key.hash() * 0x9e3779b97f4a7c15ULL) >> shift_ : 0;
+  }
+};
@@ -16,6 +16,10 @@ struct kmer_pair {
     pkmer_t next_kmer() const noexcept;
     pkmer_t last_kmer() const noexcept;
 
+    // The same k-mer read on the other strand: reverse-complemented k-mer,
+    // with the complemented extensions swapped ('F' stays 'F').
+    kmer_pair revcomp() const noexcept;
+
     // Get the forward, backward extension.
     char forwardExt() const noexcept;
     char backwardExt() const noexcept;
@@ -56,6 +60,14 @@ pkmer_t kmer_pair::last_kmer() const noexcept {
     return pkmer_t(backwardExt() + kmer_str().substr(0, kmer_str().length() - 1));
 }
 
+kmer_pair kmer_pair::revcomp() const noexcept {
+    kmer_pair rc;
+    rc.kmer = kmer.revcomp();
+    rc.fb_ext[0] = complementBase(forwardExt());
+    rc.fb_ext[1] = complementBase(backwardExt());
+    return rc;
+}
+
 void kmer_pair::print() const noexcept {
     printf("%s %s\n", kmer_str().c_str(), fb_ext_str().c_str());
 }
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <bitset>
+#include <cstdint>
+#include <vector>
+
+#include "kmer_t.hpp"
+
+// EpochKmerTable is the mutable local hash table: open addressing with linear
+// probing over kmer_pairs, keyed by their packed k-mer. Every slot records the
+// epoch it was written in and only slots of the current epoch are live, so
+// reset() empties the table in O(1) and keeps the slots for the next dataset.
+// Walker claims for canonical traversal are made only once all inserts are
+// done, so on the first claim the live entries are numbered in slot order
+// (a bit per slot plus a running count per 64 slots) and the claims array has
+// one 8-byte claim per entry, not per slot. Any new entry, rehash or reset
+// drops the claims.
+class EpochKmerTable {
+public:
+  // Make room for n entries at a load factor of at most 0.5. Only grows.
+  void reserve(size_t n) {
+    size_t capacity = 16;
+    while (capacity < 2 * n) {
+      capacity <<= 1;
+    }
+    if (capacity > slots_.size()) {
+      rehash(capacity);
+    }
+  }
+
+  // Drop all entries in O(1) by starting a new epoch.
+  void reset() {
+    size_ = 0;
+    drop_claims();
+    if (++epoch_ == 0) {
+      // Epoch counter wrapped: stale slots could look live again, clear them.
+      for (auto &s : slots_) {
+        s.epoch = 0;
+      }
+      epoch_ = 1;
+    }
+  }
+
+  // Insert, or overwrite the entry with the same k-mer. Returns false if that
+  // entry had different extensions (an identical duplicate is fine).
+  bool insert(const kmer_pair &value) {
+    if (2 * (size_ + 1) > slots_.size()) {
+      rehash(slots_.empty() ? 16 : 2 * slots_.size());
+    }
+    size_t i = home(value.kmer);
+    while (slots_[i].epoch == epoch_) {
+      if (slots_[i].value.kmer == value.kmer) {
+        bool same = (slots_[i].value == value);
+        slots_[i].value = value;
+        return same;
+      }
+      i = (i + 1) & mask_;
+    }
+    slots_[i].epoch = epoch_;
+    slots_[i].value = value;
+    drop_claims();
+    size_++;
+    return true;
+  }
+
+  // Return the entry for key, or nullptr if absent.
+  const kmer_pair *find(const pkmer_t &key) const {
+    size_t i = locate(key);
+    return (i == npos) ? nullptr : &slots_[i].value;
+  }
+
+  // Claim the entry for key for walker (nonzero) unless another walker holds
+  // it. Returns the entry, or nullptr if absent; owner is set to the holder.
+  const kmer_pair *claim(const pkmer_t &key, uint64_t walker, uint64_t &owner) {
+    size_t i = locate(key);
+    if (i == npos) {
+      return nullptr;
+    }
+    if (claims_.empty()) {
+      number_entries();
+    }
+    uint64_t &claim = claims_[entry_index(i)];
+    if (claim == 0) {
+      claim = walker;
+    }
+    owner = claim;
+    return &slots_[i].value;
+  }
+
+  size_t size() const { return size_; }
+
+  // Call f on every live entry.
+  template <typename F> void for_each(F f) const {
+    for (const auto &s : slots_) {
+      if (s.epoch == epoch_) {
+        f(s.value);
+      }
+    }
+  }
+
+private:
+  struct slot {
+    uint32_t epoch = 0;   // 0 is never a live epoch
+    kmer_pair value;
+  };
+
+  std::vector<slot> slots_;
+  // Claims, one per live entry in slot order; empty until the first claim.
+  std::vector<uint64_t> claims_;
+  // live_[w] has bit j set if slot 64 * w + j is live; live_before_[w] counts
+  // the live slots before slot 64 * w.
+  std::vector<uint64_t> live_;
+  std::vector<uint32_t> live_before_;
+  size_t mask_ = 0;
+  int shift_ = 64;
+  size_t size_ = 0;
+  uint32_t epoch_ = 1;
+
+  static constexpr size_t npos = ~size_t(0);
+
+  // Slot holding key, or npos.
+  size_t locate(const pkmer_t &key) const {
+    if (slots_.empty()) {
+      return npos;
+    }
+    size_t i = home(key);
+    while (slots_[i].epoch == epoch_) {
+      if (slots_[i].value.kmer == key) {
+        return i;
+      }
+      i = (i + 1) & mask_;
+    }
+    return npos;
+  }
+
+  void drop_claims() {
+    if (!claims_.empty()) {
+      claims_.clear();
+      live_.clear();
+      live_before_.clear();
+    }
+  }
+
+  // Number the live entries for claims_.
+  void number_entries() {
+    size_t words = (slots_.size() + 63) / 64;
+    live_.assign(words, 0);
+    live_before_.assign(words, 0);
+    uint32_t count = 0;
+    for (size_t w = 0; w < words; w++) {
+      live_before_[w] = count;
+      for (size_t j = 0; j < 64 && 64 * w + j < slots_.size(); j++) {
+        if (slots_[64 * w + j].epoch == epoch_) {
+          live_[w] |= uint64_t(1) << j;
+        }
+      }
+      count += std::bitset<64>(live_[w]).count();
+    }
+    claims_.assign(size_, 0);
+  }
+
+  // Position of live slot i among the live entries.
+  size_t entry_index(size_t i) const {
+    uint64_t below = live_[i / 64] & ((uint64_t(1) << (i % 64)) - 1);
+    return live_before_[i / 64] + std::bitset<64>(below).count();
+  }
+
+  // First slot to probe: Fibonacci hashing spreads the k-mer hash over the top bits.
+  size_t home(const pkmer_t &key) const {
+    return (size_t)((key.hash() * 0x9e3779b97f4a7c15ULL) >> shift_);
+  }
+
+  void rehash(size_t capacity) {
+    std::vector<slot> old;
+    old.swap(slots_);
+    slots_.resize(capacity);
+    drop_claims();
+    mask_ = capacity - 1;
+    shift_ = 64;
+    for (size_t c = capacity; c > 1; c >>= 1) {
+      shift_--;
+    }
+    size_ = 0;
+    for (const auto &s : old) {
+      if (s.epoch == epoch_) {
+        insert(s.value);
+      }
+    }
+  }
+};
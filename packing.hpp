@@ -49,7 +49,7 @@ void init_LookupTable() {
 
 unsigned char packFourMer(const char* fourMer) {
     int retval = 0;
-    int code, i;
+    int code = 0, i;
     int pow = 64;
 
     for (i = 0; i < 4; i++) {
@@ -105,3 +105,56 @@ void unpackKmer(const unsigned char packed_kmer[PACKED_KMER_LEN], char* kmer) {
         }
     }
 }
+
+// Reverse complement of a packed 4-mer, for every byte value.
+bool packedRevCompCoded = false;
+unsigned char packedRevComp[256];
+
+void init_RevCompTable() {
+    for (int i = 0; i < 256; i++) {
+        // Take the 2-bit codes from the last base to the first; complement is 3 - code.
+        unsigned char rc = 0;
+        for (int slot = 0; slot < 4; slot++) {
+            int code = (i >> (2 * slot)) & 3;
+            rc = (unsigned char)((rc << 2) | (3 - code));
+        }
+        packedRevComp[i] = rc;
+    }
+}
+
+char complementBase(char base) {
+    switch (base) {
+    case 'A':
+        return 'T';
+    case 'C':
+        return 'G';
+    case 'G':
+        return 'C';
+    case 'T':
+        return 'A';
+    default:
+        return base;
+    }
+}
+
+// Reverse-complement a packed k-mer without unpacking it: reverse the bytes
+// through the table, then shift out the padding bases, which end up at the
+// front, so the result is padded with A's at the end like packKmer's output.
+void revcompKmer(const unsigned char packed_kmer[PACKED_KMER_LEN],
+                 unsigned char rc_kmer[PACKED_KMER_LEN]) {
+    if (!packedRevCompCoded) {
+        packedRevCompCoded = true;
+        init_RevCompTable();
+    }
+    for (int i = 0; i < PACKED_KMER_LEN; i++) {
+        rc_kmer[i] = packedRevComp[packed_kmer[PACKED_KMER_LEN - 1 - i]];
+    }
+    const int shift = 2 * (PACKED_KMER_LEN * 4 - KMER_LEN);
+    if (shift != 0) {
+        for (int i = 0; i < PACKED_KMER_LEN; i++) {
+            unsigned char carry =
+                (i + 1 < PACKED_KMER_LEN) ? (unsigned char)(rc_kmer[i + 1] >> (8 - shift)) : 0;
+            rc_kmer[i] = (unsigned char)((rc_kmer[i] << shift) | carry);
+        }
+    }
+}
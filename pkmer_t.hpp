@@ -9,6 +9,10 @@ struct pkmer_t {
     std::string get() const noexcept;
     uint64_t hash() const noexcept;
 
+    // Reverse complement, and the smaller of the k-mer and its reverse complement.
+    pkmer_t revcomp() const noexcept;
+    pkmer_t canonical() const noexcept;
+
     // Various C++ lifetime stuff.
     pkmer_t(const std::string& kmer);
 
@@ -18,6 +22,7 @@ struct pkmer_t {
 
     bool operator==(const pkmer_t& pkmer) const noexcept;
     bool operator!=(const pkmer_t& pkmer) const noexcept;
+    bool operator<(const pkmer_t& pkmer) const noexcept;
 
     void init(const unsigned char data[PACKED_KMER_LEN]);
 };
@@ -36,6 +41,17 @@ uint64_t pkmer_t::hash() const noexcept {
     return hashval;
 }
 
+pkmer_t pkmer_t::revcomp() const noexcept {
+    pkmer_t rc;
+    revcompKmer(data, rc.data);
+    return rc;
+}
+
+pkmer_t pkmer_t::canonical() const noexcept {
+    pkmer_t rc = revcomp();
+    return (rc < *this) ? rc : *this;
+}
+
 pkmer_t::pkmer_t(const std::string& kmer) { packKmer(kmer.data(), data); }
 
 bool pkmer_t::operator==(const pkmer_t& pkmer) const noexcept {
@@ -44,6 +60,11 @@ bool pkmer_t::operator==(const pkmer_t& pkmer) const noexcept {
 
 bool pkmer_t::operator!=(const pkmer_t& pkmer) const noexcept { return !(*this == pkmer); }
 
+// Packed order is lexicographic order of the bases (A < C < G < T).
+bool pkmer_t::operator<(const pkmer_t& pkmer) const noexcept {
+    return memcmp(data, pkmer.data, PACKED_KMER_LEN) < 0;
+}
+
 void pkmer_t::init(const unsigned char data[PACKED_KMER_LEN]) {
     for (int i = 0; i < PACKED_KMER_LEN; i++) {
         this->data[i] = data[i];
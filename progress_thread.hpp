@@ -0,0 +1,117 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <thread>
+#include <upcxx/upcxx.hpp>
+
+// ProgressThread hands the master persona to a helper thread that spins on
+// upcxx::progress(), so incoming RPCs are serviced while the main thread is
+// busy in local compute (partitioning, parsing, long local walks).
+//
+// It is only active between start() and stop(). While active, the main thread
+// still issues RPCs and waits on their futures with its own default persona,
+// but collectives need the master persona and must go through barrier() or
+// reduce_all().
+// Outside the active windows the main thread holds the master persona as usual.
+// Requires a UPC++ build with UPCXX_THREADMODE=par.
+class ProgressThread {
+public:
+  explicit ProgressThread(bool enabled) : enabled_(enabled) {}
+
+  ~ProgressThread() { stop(); }
+
+  ProgressThread(const ProgressThread &) = delete;
+  ProgressThread &operator=(const ProgressThread &) = delete;
+
+  // Whether this UPC++ build allows a progress thread at all.
+  static constexpr bool available() {
+#if UPCXX_BACKEND_GASNET_PAR
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  bool running() const { return running_; }
+
+  // Give the master persona to the helper thread and start servicing RPCs.
+  void start() {
+    if (!enabled_ || running_) {
+      return;
+    }
+    if (!liberated_) {
+      upcxx::liberate_master_persona();
+      liberated_ = true;
+    } else {
+      main_scope_.reset();
+    }
+    done_ = false;
+    running_ = true;
+    thread_ = std::thread([this]() {
+      while (!done_.load(std::memory_order_relaxed)) {
+        {
+          upcxx::persona_scope scope(master_mutex_, upcxx::master_persona());
+          upcxx::progress();
+        }
+        std::this_thread::yield();
+      }
+    });
+  }
+
+  // Join the helper thread and take the master persona back.
+  void stop() {
+    if (!running_) {
+      return;
+    }
+    done_ = true;
+    thread_.join();
+    main_scope_.reset(new upcxx::persona_scope(upcxx::master_persona()));
+    running_ = false;
+  }
+
+  // Stop for good and call upcxx::finalize(); use it in place of
+  // upcxx::finalize() once a ProgressThread exists. The heap-held scope is
+  // released first, so nothing owned here outlives finalize(); the master
+  // persona is held for finalize() by a scope on this call's stack.
+  void finalize() {
+    stop();
+    if (!liberated_) {
+      upcxx::finalize();
+      return;
+    }
+    main_scope_.reset();
+    upcxx::persona_scope scope(upcxx::master_persona());
+    upcxx::finalize();
+  }
+
+  // Barrier that is safe to call whether or not the helper thread is running.
+  void barrier(const upcxx::team &team = upcxx::world()) {
+    if (!running_) {
+      upcxx::barrier(team);
+      return;
+    }
+    upcxx::persona_scope scope(master_mutex_, upcxx::master_persona());
+    upcxx::barrier(team);
+  }
+
+  // reduce_all over the world team, likewise safe while the thread runs.
+  template <typename T, typename Op> T reduce_all(const T &value, Op op) {
+    if (!running_) {
+      return upcxx::reduce_all(value, op).wait();
+    }
+    upcxx::persona_scope scope(master_mutex_, upcxx::master_persona());
+    return upcxx::reduce_all(value, op).wait();
+  }
+
+private:
+  bool enabled_;
+  bool liberated_ = false;
+  bool running_ = false;
+  std::atomic<bool> done_{false};
+  std::mutex master_mutex_;
+  std::thread thread_;
+  // Holds the master persona on the main thread once it has been taken back.
+  std::unique_ptr<upcxx::persona_scope> main_scope_;
+};
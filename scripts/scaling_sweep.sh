@@ -0,0 +1,110 @@
+#!/bin/bash
+
+# Single-machine strong/weak scaling sweep on synthetic data.
+# Run from the build directory after building kmer_gen and kmer_hash_<K>
+# with an smp or udp UPC++ conduit (e.g. UPCXX_NETWORK=smp cmake ..).
+# Writes one CSV row per run: scaling,flags,dataset,ranks,kmers,trial,read,insert,assembly,total,lookup_us
+# Run it once per flag set (-f) with -a to compare modes in one CSV.
+
+# Default values
+K=19
+RANKS="1 2 4 8"
+STRONG_CONTIGS=2000
+WEAK_CONTIGS=500
+MEAN_LEN=500
+DIST=exp
+SEED=1
+TRIALS=3
+OUT=scaling.csv
+DATA_DIR=scaling_data
+FLAGS=""
+APPEND=0
+LAUNCHER=${LAUNCHER:-"upcxx-run -n"}
+
+usage() {
+    echo "Usage: $0 [-k K] [-r \"ranks ...\"] [-s strong_contigs] [-w weak_contigs_per_rank]"
+    echo "          [-l mean_length] [-d fixed|uniform|exp] [-e seed] [-t trials]"
+    echo "          [-o out.csv]"
+    echo "          [-f \"kmer_hash flags\"] [-a (append to out.csv)]"
+    exit 1
+}
+
+# Parse command-line arguments
+while getopts "k:r:s:w:l:d:e:t:o:f:a" opt; do
+    case $opt in
+        k) K=$OPTARG ;;
+        r) RANKS=$OPTARG ;;
+        s) STRONG_CONTIGS=$OPTARG ;;
+        w) WEAK_CONTIGS=$OPTARG ;;
+        l) MEAN_LEN=$OPTARG ;;
+        d) DIST=$OPTARG ;;
+        e) SEED=$OPTARG ;;
+        t) TRIALS=$OPTARG ;;
+        o) OUT=$OPTARG ;;
+        f) FLAGS=$OPTARG ;;
+        a) APPEND=1 ;;
+        *) usage ;;
+    esac
+done
+
+BINARY=./kmer_hash_$K
+if [ ! -x "$BINARY" ] || [ ! -x ./kmer_gen ]; then
+    echo "ERROR: $BINARY and ./kmer_gen must be built first."
+    exit 1
+fi
+
+mkdir -p "$DATA_DIR"
+
+# Datasets are cached in DATA_DIR under a name that encodes every
+# generator parameter, so a rerun with other -l/-d/-e options never picks
+# up stale data.
+dataset_prefix() {
+    local scaling=$1 contigs=$2
+    echo "$DATA_DIR/${scaling}_k${K}_n${contigs}_l${MEAN_LEN}_${DIST}_s${SEED}"
+}
+
+# Generate a dataset unless it is already cached.
+generate() {
+    local prefix=$1 contigs=$2
+    if [ ! -f "$prefix.txt" ] || [ ! -f "${prefix}_solution.txt" ]; then
+        ./kmer_gen -k "$K" -n "$contigs" -l "$MEAN_LEN" -d "$DIST" -s "$SEED" "$prefix" || exit 1
+    fi
+}
+
+# Run one configuration: check the result once, then time it TRIALS times.
+run() {
+    local scaling=$1 ranks=$2 prefix=$3
+    if ! $LAUNCHER "$ranks" "$BINARY" "$prefix.txt" verify "${prefix}_solution.txt" $FLAGS > /dev/null; then
+        echo "ERROR: wrong contigs for $prefix.txt on $ranks ranks."
+        exit 1
+    fi
+    for trial in $(seq 1 "$TRIALS"); do
+        ROW=$($LAUNCHER "$ranks" "$BINARY" "$prefix.txt" bench $FLAGS | grep '^BENCH,' | cut -d, -f2-)
+        if [ -z "$ROW" ]; then
+            echo "ERROR: run failed for $prefix.txt on $ranks ranks."
+            exit 1
+        fi
+        # ROW is ranks,kmers,read,insert,assembly,total,lookup_us
+        echo "$scaling,${FLAGS:-none},$(basename "$prefix"),$(echo "$ROW" | cut -d, -f1-2),$trial,$(echo "$ROW" | cut -d, -f3-)" >> "$OUT"
+    done
+}
+
+if [ "$APPEND" -eq 0 ] || [ ! -f "$OUT" ]; then
+    echo "scaling,flags,dataset,ranks,kmers,trial,read,insert,assembly,total,lookup_us" > "$OUT"
+fi
+
+STRONG_PREFIX=$(dataset_prefix strong "$STRONG_CONTIGS")
+generate "$STRONG_PREFIX" "$STRONG_CONTIGS"
+for R in $RANKS; do
+    echo "Strong scaling: $R ranks"
+    run strong "$R" "$STRONG_PREFIX"
+done
+
+for R in $RANKS; do
+    WEAK_PREFIX=$(dataset_prefix weak $((WEAK_CONTIGS * R)))
+    generate "$WEAK_PREFIX" $((WEAK_CONTIGS * R))
+    echo "Weak scaling: $R ranks"
+    run weak "$R" "$WEAK_PREFIX"
+done
+
+echo "Wrote $OUT"
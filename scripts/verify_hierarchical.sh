@@ -0,0 +1,55 @@
+#!/bin/bash
+
+# Check --hierarchical on a single machine. Needs kmer_hash built with the
+# udp conduit (UPCXX_NETWORK=udp cmake ..): GASNET_SUPERNODE_MAXSIZE then
+# splits the local ranks into several shared-memory "nodes", so the
+# node-level routing runs with more than one node.
+
+# Default values for ranks and ranks per node
+THREADS=4
+NODE_SIZE=2
+K=19
+
+# Parse command-line arguments
+while getopts "n:s:k:" opt; do
+    case $opt in
+        n) THREADS=$OPTARG ;;
+        s) NODE_SIZE=$OPTARG ;;
+        k) K=$OPTARG ;;
+        *) echo "Usage: $0 [-n ranks] [-s ranks_per_node] [-k K] <input_file>"
+           exit 1 ;;
+    esac
+done
+shift $((OPTIND-1))
+
+# Ensure an input file is provided
+if [ $# -ne 1 ]; then
+    echo "Usage: $0 [-n ranks] [-s ranks_per_node] [-k K] <input_file>"
+    exit 1
+fi
+
+INPUT_FILE=$1
+ROOT_NAME=$(basename "$INPUT_FILE" .txt)  # Extract root name without extension
+INPUT_DIR=$(dirname "$INPUT_FILE")        # Get the directory of the input file
+
+EXPECTED_FILE="${INPUT_DIR}/${ROOT_NAME}_solution.txt"
+
+export GASNET_SPAWNFN=L
+export GASNET_SUPERNODE_MAXSIZE=$NODE_SIZE
+
+# The layout must give every "node" the same number of ranks, or kmer_hash
+# falls back to direct inserts; make sure the hierarchical path really ran.
+CMD="upcxx-run -n $THREADS ./kmer_hash_$K $INPUT_FILE verbose --hierarchical"
+echo "Running command: $CMD"
+if ! eval "$CMD" | grep -q "Hierarchical insertion enabled"; then
+    echo "FAILED: hierarchical insertion did not run with $THREADS ranks, $NODE_SIZE per node"
+    exit 1
+fi
+
+CMD="upcxx-run -n $THREADS ./kmer_hash_$K $INPUT_FILE verify $EXPECTED_FILE --hierarchical"
+echo "Running command: $CMD"
+if ! eval "$CMD"; then
+    echo "FAILED: $INPUT_FILE"
+    exit 1
+fi
+echo "PASSED: $INPUT_FILE"
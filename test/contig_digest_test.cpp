@@ -0,0 +1,221 @@
+// Checks must run in Release builds too.
+#undef NDEBUG
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "contig_digest.hpp"
+
+//--------------------------------------------------------------------
+// Plain C++ checks of the contig digest that every verify verdict rests on:
+//   - 128-bit sums: carry from hash_lo into hash_hi in add() and +=
+//   - the same digest for any contig order and any split into partials
+//   - revcomp_contig / canonical_contig
+//   - parse_digest, reference_digest, reference_available
+//--------------------------------------------------------------------
+
+typedef unsigned __int128 u128;
+
+static u128 hash128(const ContigDigest& digest) {
+    return (u128(digest.hash_hi) << 64) | digest.hash_lo;
+}
+
+static std::string random_contig(std::mt19937_64& rng) {
+    static const char BASES[4] = {'A', 'C', 'G', 'T'};
+    std::string contig(20 + rng() % 200, 'A');
+    for (auto& base : contig) {
+        base = BASES[rng() & 3];
+    }
+    return contig;
+}
+
+static void write_file(const std::string& fname, const std::string& text) {
+    std::ofstream fout(fname);
+    fout << text;
+}
+
+void test_carry(std::mt19937_64& rng) {
+    for (int i = 0; i < 1000; i++) {
+        std::string contig = random_contig(rng);
+        ContigDigest single;
+        single.add(contig);
+
+        // add(): start just below 2^64 in hash_lo so the low half wraps.
+        ContigDigest digest;
+        digest.hash_lo = ~uint64_t(0) - (rng() % 16);
+        digest.hash_hi = rng();
+        u128 expected = hash128(digest) + hash128(single);
+        digest.add(contig);
+        assert(hash128(digest) == expected);
+        assert(digest.n_contigs == 1 && digest.total_length == contig.size());
+
+        // operator+=: likewise, with both low halves large.
+        ContigDigest a, b;
+        a.hash_lo = ~uint64_t(0) - (rng() % 16);
+        a.hash_hi = rng();
+        b.hash_lo = ~uint64_t(0) - (rng() % 16);
+        b.hash_hi = rng();
+        expected = hash128(a) + hash128(b);
+        a += b;
+        assert(hash128(a) == expected);
+    }
+    // The high half wraps modulo 2^128 without trouble.
+    ContigDigest a, b;
+    a.hash_lo = a.hash_hi = ~uint64_t(0);
+    b.hash_lo = 1;
+    a += b;
+    assert(a.hash_lo == 0 && a.hash_hi == 0);
+}
+
+void test_order_independence(std::mt19937_64& rng) {
+    std::vector<std::string> contigs;
+    for (int i = 0; i < 500; i++) {
+        contigs.push_back(random_contig(rng));
+    }
+    ContigDigest reference;
+    size_t total_length = 0;
+    for (const auto& contig : contigs) {
+        reference.add(contig);
+        total_length += contig.size();
+    }
+    assert(reference.n_contigs == contigs.size() && reference.total_length == total_length);
+
+    for (int trial = 0; trial < 50; trial++) {
+        // Shuffle, split into 1-16 partial digests, combine them in any order.
+        std::shuffle(contigs.begin(), contigs.end(), rng);
+        std::vector<ContigDigest> partials(1 + rng() % 16);
+        for (const auto& contig : contigs) {
+            partials[rng() % partials.size()].add(contig);
+        }
+        std::shuffle(partials.begin(), partials.end(), rng);
+        ContigDigest combined;
+        for (const auto& partial : partials) {
+            combined = op_digest_add()(combined, partial);
+        }
+        assert(combined == reference);
+        assert(combined.hash_str() == reference.hash_str());
+    }
+
+    // Dropping or changing one contig changes the digest.
+    ContigDigest fewer, changed;
+    for (size_t i = 1; i < contigs.size(); i++) {
+        fewer.add(contigs[i]);
+        changed.add(contigs[i]);
+    }
+    std::string edited = contigs[0];
+    edited[0] = (edited[0] == 'A') ? 'C' : 'A';
+    changed.add(edited);
+    assert(fewer != reference);
+    assert(changed != reference);
+}
+
+void test_canonical_contig() {
+    assert(revcomp_contig("AACGT") == "ACGTT");
+    assert(revcomp_contig("") == "");
+    assert(canonical_contig("AAAC") == "AAAC");
+    assert(canonical_contig("TTTG") == "CAAA");
+    assert(canonical_contig("ACGT") == "ACGT");  // its own reverse complement
+    assert(canonical_contig("GTTT") == canonical_contig("AAAC"));
+}
+
+void test_parse_digest(std::mt19937_64& rng) {
+    ContigDigest digest;
+    for (int i = 0; i < 10; i++) {
+        digest.add(random_contig(rng));
+    }
+    std::string hex = digest.hash_str();
+    std::string line = "Digest " + hex + " (" + std::to_string(digest.n_contigs) + " contigs, " +
+                       std::to_string(digest.total_length) + " bases)";
+
+    ContigDigest parsed;
+    bool has_counts = false;
+    assert(parse_digest(line, parsed, has_counts));
+    assert(has_counts && parsed == digest);
+
+    parsed = ContigDigest();
+    assert(parse_digest(hex, parsed, has_counts));
+    assert(!has_counts && parsed.hash_lo == digest.hash_lo && parsed.hash_hi == digest.hash_hi);
+    assert(digest_matches(digest, parsed, has_counts));
+
+    std::string upper = hex;
+    std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
+    assert(parse_digest(upper, parsed, has_counts));
+    assert(parsed.hash_lo == digest.hash_lo && parsed.hash_hi == digest.hash_hi);
+
+    // A digest line without the counts still gives the hash.
+    assert(parse_digest("Digest " + hex, parsed, has_counts) && !has_counts);
+
+    // Bad hex: wrong length, non-hex digits, empty.
+    assert(!parse_digest(hex.substr(1), parsed, has_counts));
+    assert(!parse_digest(hex + "0", parsed, has_counts));
+    assert(!parse_digest("g" + hex.substr(1), parsed, has_counts));
+    assert(!parse_digest("", parsed, has_counts));
+    assert(!parse_digest("Digest " + hex.substr(4) + " (1 contigs, 2 bases)", parsed, has_counts));
+}
+
+void test_reference_digest(std::mt19937_64& rng) {
+    std::vector<std::string> contigs;
+    ContigDigest digest, canonical;
+    std::string solution;
+    for (int i = 0; i < 20; i++) {
+        contigs.push_back(random_contig(rng));
+        digest.add(contigs.back());
+        canonical.add(canonical_contig(contigs.back()));
+        solution += contigs.back() + "\n";
+    }
+    const std::string solution_fname = "contig_digest_test_solution.txt";
+    const std::string digest_fname = "contig_digest_test_digest.txt";
+    write_file(solution_fname, solution);
+    write_file(digest_fname, "Digest " + digest.hash_str() + " (" + std::to_string(digest.n_contigs) +
+                                 " contigs, " + std::to_string(digest.total_length) + " bases)\n");
+
+    // A solution file (not a digest) is digested, in either orientation mode.
+    bool has_counts = false;
+    assert(reference_digest(solution_fname, false, has_counts) == digest && has_counts);
+    assert(reference_digest(solution_fname, true, has_counts) == canonical && has_counts);
+
+    // A digest file is read as stored.
+    has_counts = false;
+    assert(reference_digest(digest_fname, false, has_counts) == digest && has_counts);
+
+    // Bare hex: only the hash is compared.
+    ContigDigest ref = reference_digest(digest.hash_str(), false, has_counts);
+    assert(!has_counts && digest_matches(digest, ref, has_counts));
+    assert(!digest_matches(canonical, ref, has_counts));
+
+    // Neither a file nor a digest.
+    bool threw = false;
+    try {
+        reference_digest("no_such_file.txt", false, has_counts);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+
+    assert(reference_available(solution_fname));
+    assert(reference_available(digest_fname));
+    assert(reference_available(digest.hash_str()));
+    assert(!reference_available("no_such_file.txt"));
+
+    std::remove(solution_fname.c_str());
+    std::remove(digest_fname.c_str());
+}
+
+int main() {
+    std::mt19937_64 rng(128);
+    test_carry(rng);
+    test_order_independence(rng);
+    test_canonical_contig();
+    test_parse_digest(rng);
+    test_reference_digest(rng);
+    std::cout << "contig_digest_test: PASSED" << std::endl;
+    return 0;
+}
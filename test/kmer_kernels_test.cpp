@@ -0,0 +1,230 @@
+// Checks must run in Release builds too.
+#undef NDEBUG
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "kmer_t.hpp"
+#include "kmer_table.hpp"
+#include "kmer_index.hpp"
+
+//--------------------------------------------------------------------
+// Plain C++ checks (no UPC++) of the packed k-mer kernels and the local
+// tables, for the KMER_LEN this file is compiled with:
+//   - revcompKmer / pkmer_t::revcomp / canonical against string versions
+//   - kmer_pair::revcomp
+//   - EpochKmerTable: insert, find, conflicts, rehash, reset, claims
+//   - FrozenKmerIndex: build, find, claims, rebuild
+//--------------------------------------------------------------------
+
+static const char BASES[4] = {'A', 'C', 'G', 'T'};
+
+static char complement(char base) {
+    switch (base) {
+    case 'A': return 'T';
+    case 'C': return 'G';
+    case 'G': return 'C';
+    case 'T': return 'A';
+    default: return base;
+    }
+}
+
+static std::string revcomp(const std::string& seq) {
+    std::string rc(seq.rbegin(), seq.rend());
+    for (auto& base : rc) {
+        base = complement(base);
+    }
+    return rc;
+}
+
+static std::string random_kmer(std::mt19937_64& rng) {
+    std::string kmer(KMER_LEN, 'A');
+    for (auto& base : kmer) {
+        base = BASES[rng() & 3];
+    }
+    return kmer;
+}
+
+// n distinct random k-mer pairs with random extensions.
+static std::vector<kmer_pair> random_pairs(std::mt19937_64& rng, size_t n) {
+    std::unordered_set<std::string> seen;
+    std::vector<kmer_pair> pairs;
+    while (pairs.size() < n) {
+        std::string kmer = random_kmer(rng);
+        if (!seen.insert(kmer).second) {
+            continue;
+        }
+        std::string ext = {BASES[rng() & 3], BASES[rng() & 3]};
+        pairs.push_back(kmer_pair(kmer, ext));
+    }
+    return pairs;
+}
+
+void test_revcomp(std::mt19937_64& rng) {
+    // Fixed cases, including all-A/all-T and a single differing base at each end.
+    std::vector<std::string> kmers = {std::string(KMER_LEN, 'A'), std::string(KMER_LEN, 'T'),
+                                      "C" + std::string(KMER_LEN - 1, 'A'),
+                                      std::string(KMER_LEN - 1, 'A') + "G"};
+    for (int i = 0; i < 10000; i++) {
+        kmers.push_back(random_kmer(rng));
+    }
+    for (const auto& kmer : kmers) {
+        pkmer_t packed(kmer);
+        assert(packed.get() == kmer);
+        assert(packed.revcomp().get() == revcomp(kmer));
+        assert(packed.revcomp().revcomp() == packed);
+        assert(packed.canonical().get() == std::min(kmer, revcomp(kmer)));
+        assert(packed.canonical() == packed.revcomp().canonical());
+    }
+    // Packed order is string order, which canonical() relies on.
+    for (size_t i = 1; i < kmers.size(); i++) {
+        assert((pkmer_t(kmers[i - 1]) < pkmer_t(kmers[i])) == (kmers[i - 1] < kmers[i]));
+    }
+}
+
+void test_kmer_pair_revcomp(std::mt19937_64& rng) {
+    const std::string exts = "ACGTF";
+    for (int i = 0; i < 1000; i++) {
+        std::string kmer = random_kmer(rng);
+        std::string ext = {exts[rng() % 5], exts[rng() % 5]};
+        kmer_pair pair(kmer, ext);
+        kmer_pair rc = pair.revcomp();
+        assert(rc.kmer_str() == revcomp(kmer));
+        assert(rc.backwardExt() == complement(pair.forwardExt()));
+        assert(rc.forwardExt() == complement(pair.backwardExt()));
+        assert(rc.revcomp() == pair);
+        if (pair.forwardExt() != 'F') {
+            // Stepping forward on one strand is stepping backward on the other.
+            assert(pair.next_kmer().revcomp() == rc.last_kmer());
+        }
+    }
+}
+
+void test_epoch_table(std::mt19937_64& rng) {
+    std::vector<kmer_pair> pairs = random_pairs(rng, 5000);
+    EpochKmerTable table;
+    // Starts small and has to rehash several times.
+    for (const auto& pair : pairs) {
+        assert(table.insert(pair));
+    }
+    assert(table.size() == pairs.size());
+    for (const auto& pair : pairs) {
+        const kmer_pair* entry = table.find(pair.kmer);
+        assert(entry != nullptr && *entry == pair);
+    }
+    size_t visited = 0;
+    table.for_each([&visited](const kmer_pair&) { visited++; });
+    assert(visited == pairs.size());
+
+    // An identical duplicate is accepted; other extensions are a conflict.
+    assert(table.insert(pairs[0]));
+    kmer_pair other = pairs[0];
+    other.fb_ext[0] = (other.fb_ext[0] == 'A') ? 'C' : 'A';
+    assert(!table.insert(other));
+    assert(table.size() == pairs.size());
+    table.insert(pairs[0]);
+
+    // Claims: the first walker keeps the k-mer.
+    uint64_t owner = 0;
+    assert(table.claim(pairs[1].kmer, 7, owner) != nullptr && owner == 7);
+    assert(table.claim(pairs[1].kmer, 9, owner) != nullptr && owner == 7);
+    assert(table.claim(pairs[2].kmer, 9, owner) != nullptr && owner == 9);
+
+    // Claims are kept per entry: give every entry its own walker and read
+    // them all back.
+    for (size_t i = 0; i < pairs.size(); i++) {
+        assert(table.claim(pairs[i].kmer, 100 + i, owner) != nullptr);
+    }
+    for (size_t i = 0; i < pairs.size(); i++) {
+        uint64_t expected = (i == 1) ? 7 : (i == 2) ? 9 : 100 + i;
+        assert(table.claim(pairs[i].kmer, 1, owner) != nullptr && owner == expected);
+    }
+    // Overwriting an entry keeps the claims; a new entry drops them.
+    table.insert(pairs[3]);
+    assert(table.claim(pairs[3].kmer, 1, owner) != nullptr && owner == 103);
+    kmer_pair extra = random_pairs(rng, 1)[0];
+    if (table.find(extra.kmer) == nullptr) {
+        table.insert(extra);
+        assert(table.claim(pairs[3].kmer, 1, owner) != nullptr && owner == 1);
+    }
+
+    // reset() empties the table; reinserted entries start unclaimed.
+    table.reset();
+    assert(table.size() == 0);
+    for (const auto& pair : pairs) {
+        assert(table.find(pair.kmer) == nullptr);
+    }
+    std::vector<kmer_pair> next = random_pairs(rng, 3000);
+    next.push_back(pairs[1]);
+    table.reserve(next.size());
+    for (const auto& pair : next) {
+        assert(table.insert(pair));
+    }
+    assert(table.size() == next.size());
+    assert(table.claim(pairs[1].kmer, 11, owner) != nullptr && owner == 11);
+    for (const auto& pair : next) {
+        const kmer_pair* entry = table.find(pair.kmer);
+        assert(entry != nullptr && *entry == pair);
+    }
+}
+
+void test_frozen_index(std::mt19937_64& rng) {
+    for (size_t n : {0, 1, 2, 3, 1000, 4097}) {
+        std::vector<kmer_pair> pairs = random_pairs(rng, n + 100);
+        std::vector<kmer_pair> absent(pairs.begin() + n, pairs.end());
+        pairs.resize(n);
+
+        EpochKmerTable table;
+        for (const auto& pair : pairs) {
+            table.insert(pair);
+        }
+        FrozenKmerIndex index;
+        index.build(table);
+        assert(index.size() == n);
+        for (const auto& pair : pairs) {
+            const kmer_pair* entry = index.find(pair.kmer);
+            assert(entry != nullptr && *entry == pair);
+        }
+        for (const auto& pair : absent) {
+            assert(index.find(pair.kmer) == nullptr);
+        }
+
+        uint64_t owner = 0;
+        assert(index.claim(absent[0].kmer, 5, owner) == nullptr);
+        if (n > 0) {
+            assert(index.claim(pairs[0].kmer, 5, owner) != nullptr && owner == 5);
+            assert(index.claim(pairs[0].kmer, 6, owner) != nullptr && owner == 5);
+            // A rebuild drops the claims.
+            index.build(table);
+            assert(index.claim(pairs[0].kmer, 6, owner) != nullptr && owner == 6);
+        }
+
+        // Rebuilding from a smaller table (as in a batch) keeps no stale entries.
+        table.reset();
+        for (size_t i = 0; i < n / 2; i++) {
+            table.insert(pairs[i]);
+        }
+        index.build(table);
+        assert(index.size() == n / 2);
+        for (size_t i = 0; i < n; i++) {
+            assert((index.find(pairs[i].kmer) != nullptr) == (i < n / 2));
+        }
+    }
+}
+
+int main() {
+    std::mt19937_64 rng(267);
+    test_revcomp(rng);
+    test_kmer_pair_revcomp(rng);
+    test_epoch_table(rng);
+    test_frozen_index(rng);
+    std::cout << "kmer_kernels_test (K=" << KMER_LEN << "): PASSED" << std::endl;
+    return 0;
+}